@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "deque.h"
+
+// Bounded single-threaded channel over Deque<T>. co_await pop() suspends while it is empty,
+// co_await push() suspends while it is full. Woken coroutines are resumed in batches through
+// executor.post(callable), which must run the callable later on the same thread.
+// The channel must not be destroyed while a push or pop is suspended on it. Coroutines already
+// woken keep their pending resumption: the posted flush owns the ready list, not the channel.
+// An exception escaping a resumed coroutine propagates out of the posted callable; the rest of the
+// batch is resumed by a newly posted flush, and no coroutine is resumed twice.
+template<typename T, typename Executor>
+class AsyncDeque {
+private:
+    struct Waiter {
+        std::coroutine_handle<> mHandle;
+        Waiter* mNext = nullptr;
+    };
+
+    struct ReadyQueue {
+        Executor& mExecutor;
+        std::vector<std::coroutine_handle<>> mReady;
+        std::vector<std::coroutine_handle<>> mResuming;
+        size_t mNext = 0;
+        bool mFlushPosted = false;
+
+        explicit ReadyQueue(Executor& executor) : mExecutor(executor) {}
+    };
+
+    struct WaitList {
+        Waiter* mHead = nullptr;
+        Waiter* mTail = nullptr;
+
+        bool empty() const noexcept {
+            return mHead == nullptr;
+        }
+        void push(Waiter* waiter) noexcept {
+            if (mTail == nullptr) {
+                mHead = waiter;
+            } else {
+                mTail->mNext = waiter;
+            }
+            mTail = waiter;
+        }
+        Waiter* pop() noexcept {
+            Waiter* waiter = mHead;
+            mHead = waiter->mNext;
+            if (mHead == nullptr) {
+                mTail = nullptr;
+            }
+            return waiter;
+        }
+    };
+
+    Deque<T> mQueue;
+    size_t mCapacity;
+    WaitList mPoppers;
+    WaitList mPushers;
+    std::shared_ptr<ReadyQueue> mReadyQueue;
+
+public:
+    class PopAwaiter : private Waiter {
+    private:
+        AsyncDeque* mChannel;
+        std::optional<T> mValue;
+
+        friend class AsyncDeque;
+
+    public:
+        explicit PopAwaiter(AsyncDeque* channel) : mChannel(channel) {}
+        PopAwaiter(const PopAwaiter&) = delete;
+        PopAwaiter& operator=(const PopAwaiter&) = delete;
+
+        bool await_ready() {
+            return mChannel->tryTake(mValue);
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            this->mHandle = handle;
+            mChannel->mPoppers.push(this);
+        }
+        T await_resume() {
+            return std::move(*mValue);
+        }
+    };
+
+    class PushAwaiter : private Waiter {
+    private:
+        AsyncDeque* mChannel;
+        T mValue;
+
+        friend class AsyncDeque;
+
+    public:
+        PushAwaiter(AsyncDeque* channel, const T& value) : mChannel(channel), mValue(value) {}
+        PushAwaiter(const PushAwaiter&) = delete;
+        PushAwaiter& operator=(const PushAwaiter&) = delete;
+
+        bool await_ready() {
+            return mChannel->tryPut(mValue);
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            this->mHandle = handle;
+            mChannel->mPushers.push(this);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    AsyncDeque(Executor& executor, size_t capacity);
+    AsyncDeque(const AsyncDeque&) = delete;
+    AsyncDeque& operator=(const AsyncDeque&) = delete;
+    ~AsyncDeque();
+
+    PopAwaiter pop();
+    PushAwaiter push(const T& value);
+    size_t size() const noexcept;
+    size_t capacity() const noexcept;
+    bool empty() const noexcept;
+
+private:
+    bool tryTake(std::optional<T>& value);
+    bool tryPut(T& value);
+    void schedule(std::coroutine_handle<> handle);
+    static void post(const std::shared_ptr<ReadyQueue>& queue);
+    static void flush(const std::shared_ptr<ReadyQueue>& queue);
+};
+
+template<typename T, typename Executor>
+AsyncDeque<T, Executor>::AsyncDeque(Executor& executor, size_t capacity) : mCapacity(capacity),
+    mReadyQueue(std::make_shared<ReadyQueue>(executor)) {}
+
+template<typename T, typename Executor>
+AsyncDeque<T, Executor>::~AsyncDeque() {
+    assert(mPoppers.empty() && mPushers.empty());
+}
+
+template<typename T, typename Executor>
+typename AsyncDeque<T, Executor>::PopAwaiter AsyncDeque<T, Executor>::pop() {
+    return PopAwaiter(this);
+}
+
+template<typename T, typename Executor>
+typename AsyncDeque<T, Executor>::PushAwaiter AsyncDeque<T, Executor>::push(const T& value) {
+    return PushAwaiter(this, value);
+}
+
+template<typename T, typename Executor>
+size_t AsyncDeque<T, Executor>::size() const noexcept {
+    return mQueue.size();
+}
+
+template<typename T, typename Executor>
+size_t AsyncDeque<T, Executor>::capacity() const noexcept {
+    return mCapacity;
+}
+
+template<typename T, typename Executor>
+bool AsyncDeque<T, Executor>::empty() const noexcept {
+    return mQueue.size() == 0;
+}
+
+template<typename T, typename Executor>
+bool AsyncDeque<T, Executor>::tryTake(std::optional<T>& value) {
+    if (mQueue.size() == 0) {
+        if (mPushers.empty()) {
+            return false;
+        }
+        PushAwaiter* pusher = static_cast<PushAwaiter*>(mPushers.pop());
+        value.emplace(std::move(pusher->mValue));
+        schedule(pusher->mHandle);
+        return true;
+    }
+    value.emplace(*mQueue.cbegin());
+    if (mPushers.empty()) {
+        mQueue.pop_front();
+        return true;
+    }
+    PushAwaiter* pusher = static_cast<PushAwaiter*>(mPushers.mHead);
+    mQueue.push_back(pusher->mValue);
+    mQueue.pop_front();
+    mPushers.pop();
+    schedule(pusher->mHandle);
+    return true;
+}
+
+template<typename T, typename Executor>
+bool AsyncDeque<T, Executor>::tryPut(T& value) {
+    if (!mPoppers.empty()) {
+        PopAwaiter* popper = static_cast<PopAwaiter*>(mPoppers.mHead);
+        popper->mValue.emplace(std::move(value));
+        mPoppers.pop();
+        schedule(popper->mHandle);
+        return true;
+    }
+    if (mQueue.size() < mCapacity) {
+        mQueue.push_back(value);
+        return true;
+    }
+    return false;
+}
+
+template<typename T, typename Executor>
+void AsyncDeque<T, Executor>::schedule(std::coroutine_handle<> handle) {
+    mReadyQueue->mReady.push_back(handle);
+    if (!mReadyQueue->mFlushPosted) {
+        post(mReadyQueue);
+    }
+}
+
+template<typename T, typename Executor>
+void AsyncDeque<T, Executor>::post(const std::shared_ptr<ReadyQueue>& queue) {
+    queue->mExecutor.post([queue] { flush(queue); });
+    queue->mFlushPosted = true;
+}
+
+template<typename T, typename Executor>
+void AsyncDeque<T, Executor>::flush(const std::shared_ptr<ReadyQueue>& queue) {
+    ReadyQueue& ready = *queue;
+    ready.mFlushPosted = false;
+    if (ready.mNext == ready.mResuming.size()) {
+        ready.mResuming.clear();
+        ready.mNext = 0;
+        ready.mResuming.swap(ready.mReady);
+    } else if (!ready.mReady.empty()) {
+        post(queue);
+    }
+    try {
+        while (ready.mNext < ready.mResuming.size()) {
+            ready.mResuming[ready.mNext++].resume();
+        }
+    }
+    catch (...) {
+        if (ready.mNext < ready.mResuming.size() && !ready.mFlushPosted) {
+            post(queue);
+        }
+        throw;
+    }
+}
@@ -0,0 +1,217 @@
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "async_deque.h"
+
+// Both variants run producer and consumer coroutines on one event-loop thread. The bridge variant
+// routes messages through a condition-variable guarded Deque and a bridge thread that posts
+// consumer resumptions back to the loop.
+
+static const int kMessages = 2000000;
+static const int kYieldEvery = 64;
+static const size_t kCapacity = 256;
+
+struct EventLoop {
+    std::mutex mMutex;
+    std::condition_variable mWakeup;
+    std::deque<std::function<void()>> mTasks;
+    bool mStopped = false;
+
+    template<typename F>
+    void post(F&& task) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.emplace_back(std::forward<F>(task));
+        }
+        mWakeup.notify_one();
+    }
+    void stop() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopped = true;
+    }
+    void run() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (!mStopped) {
+            mWakeup.wait(lock, [this] { return mStopped || !mTasks.empty(); });
+            while (!mTasks.empty()) {
+                std::function<void()> task = std::move(mTasks.front());
+                mTasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+    }
+};
+
+struct Task {
+    struct promise_type {
+        Task get_return_object() {
+            return Task{};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+struct Yield {
+    EventLoop& mLoop;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> handle) {
+        mLoop.post(handle);
+    }
+    void await_resume() const noexcept {}
+};
+
+class CvBridge {
+private:
+    EventLoop& mLoop;
+    std::mutex mMutex;
+    std::condition_variable mChanged;
+    Deque<int> mQueue;
+    std::coroutine_handle<> mWaiter;
+    int* mSlot = nullptr;
+    bool mStopped = false;
+    std::thread mWorker;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mChanged.wait(lock, [this] { return mStopped || (mWaiter && mQueue.size() > 0); });
+            if (mStopped) {
+                return;
+            }
+            *mSlot = *mQueue.cbegin();
+            mQueue.pop_front();
+            std::coroutine_handle<> waiter = mWaiter;
+            mWaiter = nullptr;
+            mLoop.post(waiter);
+        }
+    }
+
+public:
+    class PopAwaiter {
+    private:
+        CvBridge& mBridge;
+        int mValue = 0;
+
+    public:
+        explicit PopAwaiter(CvBridge& bridge) : mBridge(bridge) {}
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            {
+                std::lock_guard<std::mutex> lock(mBridge.mMutex);
+                mBridge.mWaiter = handle;
+                mBridge.mSlot = &mValue;
+            }
+            mBridge.mChanged.notify_one();
+        }
+        int await_resume() const noexcept {
+            return mValue;
+        }
+    };
+
+    explicit CvBridge(EventLoop& loop) : mLoop(loop), mWorker([this] { work(); }) {}
+    ~CvBridge() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopped = true;
+        }
+        mChanged.notify_one();
+        mWorker.join();
+    }
+    void push(int value) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(value);
+        }
+        mChanged.notify_one();
+    }
+    PopAwaiter pop() {
+        return PopAwaiter(*this);
+    }
+};
+
+static long gChecksum = 0;
+
+static Task produceAsync(AsyncDeque<int, EventLoop>& channel, EventLoop& loop) {
+    for (int i = 0; i < kMessages; ++i) {
+        co_await channel.push(i);
+        if (i % kYieldEvery == 0) {
+            co_await Yield{loop};
+        }
+    }
+}
+
+static Task consumeAsync(AsyncDeque<int, EventLoop>& channel, EventLoop& loop) {
+    for (int i = 0; i < kMessages; ++i) {
+        gChecksum += co_await channel.pop();
+    }
+    loop.stop();
+}
+
+static Task produceBridge(CvBridge& bridge, EventLoop& loop) {
+    for (int i = 0; i < kMessages; ++i) {
+        bridge.push(i);
+        if (i % kYieldEvery == 0) {
+            co_await Yield{loop};
+        }
+    }
+}
+
+static Task consumeBridge(CvBridge& bridge, EventLoop& loop) {
+    for (int i = 0; i < kMessages; ++i) {
+        gChecksum += co_await bridge.pop();
+    }
+    loop.stop();
+}
+
+template<typename Run>
+static void measure(const char* name, Run run) {
+    gChecksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-22s %8.2f M msg/s  (checksum %ld)\n", name, kMessages / seconds / 1e6, gChecksum);
+}
+
+int main() {
+    measure("AsyncDeque", [] {
+        EventLoop loop;
+        AsyncDeque<int, EventLoop> channel(loop, kCapacity);
+        loop.post([&] {
+            consumeAsync(channel, loop);
+            produceAsync(channel, loop);
+        });
+        loop.run();
+    });
+    measure("condition-variable", [] {
+        EventLoop loop;
+        CvBridge bridge(loop);
+        loop.post([&] {
+            consumeBridge(bridge, loop);
+            produceBridge(bridge, loop);
+        });
+        loop.run();
+    });
+    return 0;
+}
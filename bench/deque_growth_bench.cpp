@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include "deque.h"
+
+static const int kRounds = 10;
+static const int kPushes = 4000000;
+
+template<typename Push>
+static void measure(const char* name, Push push) {
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        checksum += push();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-28s %8.1f M pushes/s  (checksum %ld)\n", name,
+                static_cast<double>(kRounds) * kPushes / seconds / 1e6, checksum);
+}
+
+int main() {
+    measure("Deque push_back", [] {
+        Deque<int> deque;
+        for (int i = 0; i < kPushes; ++i) {
+            deque.push_back(i);
+        }
+        return static_cast<long>(deque.size());
+    });
+    measure("Deque push_front", [] {
+        Deque<int> deque;
+        for (int i = 0; i < kPushes; ++i) {
+            deque.push_front(i);
+        }
+        return static_cast<long>(deque.size());
+    });
+    measure("Deque alternating ends", [] {
+        Deque<int> deque;
+        for (int i = 0; i < kPushes / 2; ++i) {
+            deque.push_back(i);
+            deque.push_front(i);
+        }
+        return static_cast<long>(deque.size());
+    });
+    measure("std::deque push_back", [] {
+        std::deque<int> deque;
+        for (int i = 0; i < kPushes; ++i) {
+            deque.push_back(i);
+        }
+        return static_cast<long>(deque.size());
+    });
+    measure("std::deque alternating ends", [] {
+        std::deque<int> deque;
+        for (int i = 0; i < kPushes / 2; ++i) {
+            deque.push_back(i);
+            deque.push_front(i);
+        }
+        return static_cast<long>(deque.size());
+    });
+    return 0;
+}
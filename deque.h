@@ -1,6 +1,9 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <exception>
+#include <atomic>
 
 const size_t kSize = 16;
 const int kIntSize = static_cast<int>(kSize);
@@ -8,12 +11,20 @@ const int kIntSize = static_cast<int>(kSize);
 template<typename T>
 class Deque {
 private:
+    struct SharedChunk {
+        std::atomic<size_t> refs{1};
+        size_t first = 0;
+        size_t last = 0;
+    };
+
     size_t mBegin;
     size_t mBeginIndex;
     size_t mEnd;
     size_t mEndIndex;
     size_t mCapacity;
     std::vector<T*> mArray;
+    std::vector<SharedChunk*> mShared;
+    size_t mSharedCount;
 
 public:
     template<bool Const>
@@ -22,6 +33,7 @@ public:
     using iterator = Iterator<false>;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using reverse_const_iterator = std::reverse_iterator<const_iterator>;
+    class Snapshot;
 
     template<bool Const>
     class Iterator{
@@ -37,7 +49,7 @@ public:
         int mExternalIndex;
         T** mPtr;
 
-        friend void Deque<T>::insert(iterator it, const T& value);
+        friend void Deque<T>::erase(iterator it);
 
     public:
         Iterator(T** newPtr, size_t index, size_t start) : mInternalIndex(static_cast<int>(index)),
@@ -162,6 +174,80 @@ public:
         }
     };
 
+    // Read-only point-in-time view sharing chunks with the deque it was taken from.
+    // snapshot() invalidates mutable iterators, pointers and references obtained from the deque
+    // before the call: writing through them would change the snapshot. Obtain them again afterwards.
+    class Snapshot {
+    private:
+        size_t mBeginIndex;
+        size_t mEnd;
+        size_t mEndIndex;
+        std::vector<T*> mArray;
+        std::vector<SharedChunk*> mShared;
+
+        friend class Deque<T>;
+
+        Snapshot(size_t count, size_t beginIndex, size_t end, size_t endIndex) : mBeginIndex(beginIndex),
+            mEnd(end), mEndIndex(endIndex), mArray(count, nullptr), mShared(count, nullptr) {}
+
+    public:
+        Snapshot(const Snapshot& other) : mBeginIndex(other.mBeginIndex), mEnd(other.mEnd),
+            mEndIndex(other.mEndIndex), mArray(other.mArray), mShared(other.mShared) {
+            for (SharedChunk* shared : mShared) {
+                if (shared != nullptr) {
+                    shared->refs.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        ~Snapshot() {
+            for (size_t i = 0; i < mShared.size(); ++i) {
+                if (mShared[i] != nullptr) {
+                    Deque<T>::release(mArray[i], mShared[i]);
+                }
+            }
+        }
+        Snapshot& operator=(const Snapshot& other) {
+            if (this == &other) {
+                return *this;
+            }
+            Snapshot copy(other);
+            std::swap(mBeginIndex, copy.mBeginIndex);
+            std::swap(mEnd, copy.mEnd);
+            std::swap(mEndIndex, copy.mEndIndex);
+            mArray.swap(copy.mArray);
+            mShared.swap(copy.mShared);
+            return *this;
+        }
+        size_t size() const noexcept {
+            return mEnd * kSize + mEndIndex - mBeginIndex - 1;
+        }
+        const T& operator[](size_t index) const {
+            index += (mBeginIndex + 1);
+            return mArray[index / kSize][index % kSize];
+        }
+        const T& at(size_t index) const {
+            if (index >= size()) {
+                throw std::out_of_range("index out of range");
+            }
+            return (*this)[index];
+        }
+        const_iterator begin() const noexcept {
+            if (mBeginIndex == kSize - 1) {
+                return const_iterator(const_cast<T**>(&mArray[1]), 0, 1);
+            }
+            return const_iterator(const_cast<T**>(&mArray[0]), mBeginIndex + 1, 0);
+        }
+        const_iterator end() const noexcept {
+            return const_iterator(const_cast<T**>(&mArray[mEnd]), mEndIndex, mEnd);
+        }
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+        const_iterator cend() const noexcept {
+            return end();
+        }
+    };
+
 public:
     ~Deque();
     Deque();
@@ -181,24 +267,36 @@ public:
     void pop_back();
     void push_front(const T& value);
     void pop_front();
-    iterator begin() noexcept;
-    iterator end() noexcept;
+    iterator begin();
+    iterator end();
     const_iterator begin() const noexcept;
     const_iterator end() const noexcept;
     const_iterator cbegin() const noexcept;
     const_iterator cend() const noexcept;
-    reverse_iterator rbegin() noexcept;
-    reverse_iterator rend() noexcept;
+    reverse_iterator rbegin();
+    reverse_iterator rend();
     reverse_const_iterator rbegin() const noexcept;
     reverse_const_iterator rend() const noexcept;
     reverse_const_iterator crbegin() const noexcept;
     reverse_const_iterator crend() const noexcept;
     void erase(iterator it);
     void insert(iterator it, const T& value);
+    Snapshot snapshot();
 
 private:
-    void reserveFromClear(size_t capacity);
+    static void release(T* chunk, SharedChunk* shared);
+    void disposeChunk(T* chunk, SharedChunk* shared, size_t index) const noexcept;
+    size_t chunkBegin(size_t index) const noexcept;
+    size_t chunkEnd(size_t index) const noexcept;
+    void unshare(size_t index);
+    void unshare(size_t first, size_t last);
+    iterator makeBegin() noexcept;
+    iterator makeEnd() noexcept;
+    static T* allocateChunk();
+    void reserveFromClear(size_t capacity, size_t first, size_t last);
     void expand(size_t capacity);
+    void reserveBack();
+    void reserveFront();
     void checkEndMinus();
     void checkEndPlus();
     void checkBeginMinus();
@@ -222,14 +320,14 @@ Deque<T>::~Deque() {
 
 template<typename T>
 Deque<T>::Deque() : mBegin(kSize / 2 - 1), mBeginIndex(kSize - 1), mEnd(kSize / 2), mEndIndex(0) {
-    reserveFromClear(kSize);
+    reserveFromClear(kSize, mBegin, mEnd);
 }
 
 template<typename T>
 Deque<T>::Deque(const Deque<T>& copy) : mBegin(copy.mBegin), mBeginIndex(copy.mBeginIndex),
     mEnd(copy.mBegin), mEndIndex(copy.mBeginIndex + 1) {
     try {
-        reserveFromClear(copy.mCapacity);
+        reserveFromClear(copy.mCapacity, copy.mBegin, copy.mEnd);
         for (size_t j = mBeginIndex + 1; j < kSize; ++j, ++mEndIndex) {
             new(mArray[mBegin] + j) T(copy.mArray[mBegin][j]);
         }
@@ -257,12 +355,12 @@ Deque<T>::Deque(int newSize, const T& value) {
         throw std::runtime_error("bad size");
     } else {
         mCapacity = static_cast<size_t>(2 * std::max((newSize + kIntSize - 1) / kIntSize, kIntSize / 2));
-        reserveFromClear(mCapacity);
     }
     mBegin = (mCapacity - static_cast<size_t>(newSize) / kSize) / 2;
     mBeginIndex = kSize - 1;
     mEnd = mBegin + 1;
     mEndIndex = 0;
+    reserveFromClear(mCapacity, mBegin, mEnd + static_cast<size_t>(newSize) / kSize);
     try {
         for (int i = 1; i <= newSize; ++i) {
             new(mArray[mEnd] + mEndIndex)  T(value);
@@ -279,22 +377,29 @@ template<typename T>
 Deque<T>::Deque(int newSize) : Deque(newSize, T()) {};
 
 template<typename T>
-void Deque<T>::reserveFromClear(size_t capacity) {
-    size_t count = 0;
+T* Deque<T>::allocateChunk() {
+    return reinterpret_cast<T*>(new uint8_t[sizeof(T) * kSize]);
+}
+
+template<typename T>
+void Deque<T>::reserveFromClear(size_t capacity, size_t first, size_t last) {
     try {
         mCapacity = capacity;
-        mArray.resize(capacity);
-        for (size_t i = 0; i < capacity; ++i) {
-            mArray[i] = reinterpret_cast<T*>(new uint8_t[sizeof(T) * kSize]);
-            ++count;
+        mArray.assign(capacity, nullptr);
+        mShared.assign(capacity, nullptr);
+        mSharedCount = 0;
+        for (size_t i = first; i <= last; ++i) {
+            mArray[i] = allocateChunk();
         }
     }
     catch(...) {
-        for (size_t i = 0; i < count; ++i) {
-            delete[] reinterpret_cast<uint8_t*>(mArray[i]);
+        for (T* chunk : mArray) {
+            delete[] reinterpret_cast<uint8_t*>(chunk);
         }
         mCapacity = 0;
         mArray.clear();
+        mShared.clear();
+        mSharedCount = 0;
         throw;
     }
 }
@@ -302,34 +407,12 @@ void Deque<T>::reserveFromClear(size_t capacity) {
 template<typename T>
 void Deque<T>::clear() {
     if (mCapacity > 0) {
-        if (mBegin == mEnd) {
-            for (size_t j = mBeginIndex + 1; j < mEndIndex; ++j) {
-                (mArray[mBegin] + j)->~T();
-            }
-            delete[] reinterpret_cast<uint8_t *>(mArray[mBegin]);
-        } else {
-            for (size_t j = mBeginIndex + 1; j < kSize; ++j) {
-                (mArray[mBegin] + j)->~T();
-            }
-            delete[] reinterpret_cast<uint8_t *>(mArray[mBegin]);
-            for (size_t j = 0; j < mEndIndex; ++j) {
-                (mArray[mEnd] + j)->~T();
-            }
-            delete[] reinterpret_cast<uint8_t *>(mArray[mEnd]);
-            for (size_t i = mBegin + 1; i < mEnd; ++i) {
-                for (size_t j = 0; j < kSize; ++j) {
-                    (mArray[i] + j)->~T();
-                }
-                delete[] reinterpret_cast<uint8_t *>(mArray[i]);
-            }
-        }
-        for (size_t i = 0; i < mBegin; ++i) {
-            delete[] reinterpret_cast<uint8_t *>(mArray[i]);
-        }
-        for (size_t i = mEnd + 1; i < mCapacity; ++i) {
-            delete[] reinterpret_cast<uint8_t *>(mArray[i]);
+        for (size_t i = 0; i < mCapacity; ++i) {
+            disposeChunk(mArray[i], mShared[i], i);
         }
         mArray.clear();
+        mShared.clear();
+        mSharedCount = 0;
         mCapacity = 0;
     }
 }
@@ -339,53 +422,48 @@ Deque<T>& Deque<T>::operator=(const Deque<T>& other) {
     if (this == &other) {
         return *this;
     }
-    std::vector<T*> backup(mArray);
-    size_t count = 0;
+    std::vector<T*> backup;
+    std::vector<SharedChunk*> sharedBackup;
+    backup.swap(mArray);
+    sharedBackup.swap(mShared);
+    size_t capacityBackup = mCapacity;
+    size_t sharedCountBackup = mSharedCount;
+    size_t i = other.mBegin;
+    size_t j = other.chunkBegin(i);
     try {
-        mArray.clear();
-        reserveFromClear(other.mCapacity);
-        for (size_t i = other.mBeginIndex + 1; i < kSize; ++i, ++count) {
-            new(mArray[other.mBegin] + i) T(*(other.mArray[other.mBegin] + i));
-        }
-        for (size_t i = other.mBegin + 1; i < other.mEnd; ++i) {
-            for (size_t j = 0; j < kSize; ++j, ++count) {
-                new(mArray[i] + j) T(*(other.mArray[i] + j));
+        reserveFromClear(other.mCapacity, other.mBegin, other.mEnd);
+        for (; i <= other.mEnd; ++i) {
+            for (j = other.chunkBegin(i); j < other.chunkEnd(i); ++j) {
+                new(mArray[i] + j) T(other.mArray[i][j]);
             }
         }
-        for (size_t i = 0; i < other.mEndIndex; ++i, ++count) {
-            new(mArray[other.mEnd] + i) T(*(other.mArray[other.mEnd] + i));
-        }
-        mBegin = other.mBegin;
-        mEnd = other.mEnd;
-        mBeginIndex = other.mBeginIndex;
-        mEndIndex = other.mEndIndex;
     } catch (...) {
-        for (size_t i = other.mBeginIndex + 1; i < kSize; ++i, --count) {
-            if (count == 0) {
-                break;
-            }
-            (mArray[other.mBegin] + i)->~T();
-        }
-        for (size_t i = other.mBegin + 1; i < other.mEnd; ++i) {
-            if (count == 0) {
-                break;
-            }
-            for (size_t j = 0; j < kSize; ++j, --count) {
-                if (count == 0) {
-                    break;
+        if (!mArray.empty()) {
+            for (size_t k = other.mBegin; k < i; ++k) {
+                for (size_t l = other.chunkBegin(k); l < other.chunkEnd(k); ++l) {
+                    (mArray[k] + l)->~T();
                 }
-                (mArray[i] + j)->~T();
             }
-        }
-        for (size_t i = 0; i < other.mEndIndex; ++i, --count) {
-            if (count == 0) {
-                break;
+            for (size_t l = other.chunkBegin(i); l < j; ++l) {
+                (mArray[i] + l)->~T();
             }
-            (mArray[other.mEnd] + i)->~T();
         }
-        mArray = backup;
+        for (T* chunk : mArray) {
+            delete[] reinterpret_cast<uint8_t *>(chunk);
+        }
+        mArray.swap(backup);
+        mShared.swap(sharedBackup);
+        mCapacity = capacityBackup;
+        mSharedCount = sharedCountBackup;
         throw;
     }
+    for (size_t k = 0; k < backup.size(); ++k) {
+        disposeChunk(backup[k], sharedBackup[k], k);
+    }
+    mBegin = other.mBegin;
+    mEnd = other.mEnd;
+    mBeginIndex = other.mBeginIndex;
+    mEndIndex = other.mEndIndex;
     return *this;
 }
 
@@ -397,6 +475,7 @@ size_t Deque<T>::size() const noexcept {
 template<typename T>
 T& Deque<T>::operator[](size_t index) {
     index += (mBeginIndex + 1);
+    unshare(index / kSize + mBegin);
     return mArray[index / kSize + mBegin][index % kSize];
 }
 
@@ -412,6 +491,7 @@ T& Deque<T>::at(size_t index) {
         throw std::out_of_range("index out of range");
     } else {
         index += (mBeginIndex + 1);
+        unshare(index / kSize + mBegin);
         return mArray[index / kSize + mBegin][index % kSize];
     }
 }
@@ -428,69 +508,74 @@ const T& Deque<T>::at(size_t index) const {
 
 template<typename T>
 void Deque<T>::expand(size_t capacity) {
-    size_t count = 0;
-    size_t newBegin = (capacity - (mEnd - mBegin)) / 2;
-    std::vector<T *> newArray(capacity);
-    try {
-        if (newBegin > mBegin) {
-            for (size_t j = 0; j < newBegin - mBegin; ++j) {
-                newArray[j] = reinterpret_cast<T *>(new uint8_t[sizeof(T) * kSize]);
-                ++count;
-            }
-        }
-        for (size_t j = newBegin - mBegin + mCapacity; j < capacity; ++j) {
-            newArray[j] = reinterpret_cast<T *>(new uint8_t[sizeof(T) * kSize]);
-            ++count;
-        }
-        for (size_t i = 0, j = newBegin - mBegin; i < mCapacity; ++i, ++j) {
-            newArray[j] = mArray[i];
-        }
-        mArray.resize(capacity);
-        for (size_t i = 0; i < capacity; ++i) {
-            mArray[i] = newArray[i];
-        }
-        mCapacity = capacity;
-        mEnd = newBegin + mEnd - mBegin;
-        mBegin = newBegin;
+    size_t used = mEnd - mBegin + 1;
+    size_t newBegin = (capacity - used) / 2;
+    std::vector<T*> newArray(capacity, nullptr);
+    std::vector<SharedChunk*> newShared(capacity, nullptr);
+    for (size_t i = 0; i < used; ++i) {
+        newArray[newBegin + i] = mArray[mBegin + i];
+        newShared[newBegin + i] = mShared[mBegin + i];
     }
-    catch(...) {
-        if (count <= newBegin - mBegin) {
-            for (size_t j = 0; j < count; ++j) {
-                delete[] reinterpret_cast<uint8_t*>(newArray[j]);
-            }
-        } else {
-            for (size_t j = 0; j < newBegin - mBegin; ++j) {
-                delete[] reinterpret_cast<uint8_t*>(newArray[j]);
-            }
-            for (size_t j = newBegin - mBegin + mCapacity; j < count - newBegin + mBegin; ++j) {
-                delete[] reinterpret_cast<uint8_t*>(newArray[j]);
-            }
-        }
-        throw;
+    size_t i = mBegin;
+    for (size_t j = newBegin; i > 0 && j > 0; --i, --j) {
+        newArray[j - 1] = mArray[i - 1];
+    }
+    for (; i > 0; --i) {
+        delete[] reinterpret_cast<uint8_t*>(mArray[i - 1]);
+    }
+    i = mEnd + 1;
+    for (size_t j = newBegin + used; i < mCapacity && j < capacity; ++i, ++j) {
+        newArray[j] = mArray[i];
     }
+    for (; i < mCapacity; ++i) {
+        delete[] reinterpret_cast<uint8_t*>(mArray[i]);
+    }
+    mArray.swap(newArray);
+    mShared.swap(newShared);
+    mCapacity = capacity;
+    mEnd = newBegin + used - 1;
+    mBegin = newBegin;
 }
 
 template<typename T>
-void Deque<T>::push_back(const T& value) {
-    new(mArray[mEnd] + mEndIndex)  T(value);
-    checkEndPlus();
-    try {
-        if (mEnd + 1 == mArray.size()) {
-            expand(2 * mCapacity);
-        }
+void Deque<T>::reserveBack() {
+    if (mEndIndex != kSize - 1) {
+        return;
     }
-    catch(...) {
-        checkEndMinus();
-        (mArray[mEnd] + mEndIndex)->~T();
-        throw;
+    if (mEnd + 2 >= mCapacity) {
+        expand(2 * mCapacity);
+    }
+    if (mArray[mEnd + 1] == nullptr) {
+        mArray[mEnd + 1] = allocateChunk();
+    }
+}
+
+template<typename T>
+void Deque<T>::reserveFront() {
+    if (mBeginIndex != 0) {
+        return;
+    }
+    if (mBegin <= 2) {
+        expand(2 * mCapacity);
+    }
+    if (mArray[mBegin - 1] == nullptr) {
+        mArray[mBegin - 1] = allocateChunk();
     }
 }
 
+template<typename T>
+void Deque<T>::push_back(const T& value) {
+    reserveBack();
+    new(mArray[mEnd] + mEndIndex) T(value);
+    checkEndPlus();
+}
+
 template<typename T>
 void Deque<T>::pop_back() {
     if (size() == 0) {
         throw std::runtime_error("zero size");
     } else {
+        unshare(mEndIndex == 0 ? mEnd - 1 : mEnd);
         checkEndMinus();
         (mArray[mEnd] + mEndIndex)->~T();
     }
@@ -498,18 +583,9 @@ void Deque<T>::pop_back() {
 
 template<typename T>
 void Deque<T>::push_front(const T& value) {
+    reserveFront();
     new(mArray[mBegin] + mBeginIndex) T(value);
     checkBeginMinus();
-    if (mBegin <= 1) {
-        try {
-            expand(2 * mCapacity);
-        }
-        catch(...) {
-            (mArray[mBegin] + mBeginIndex)->~T();
-            checkBeginPlus();
-            throw;
-        }
-    }
 }
 
 template<typename T>
@@ -517,13 +593,26 @@ void Deque<T>::pop_front() {
     if (size() == 0) {
         throw std::runtime_error("zero size");
     } else {
+        unshare(mBeginIndex == kSize - 1 ? mBegin + 1 : mBegin);
         checkBeginPlus();
         (mArray[mBegin] + mBeginIndex)->~T();
     }
 }
 
 template<typename T>
-typename Deque<T>::iterator Deque<T>::begin() noexcept {
+typename Deque<T>::iterator Deque<T>::begin() {
+    unshare(mBegin, mEnd);
+    return makeBegin();
+}
+
+template<typename T>
+typename Deque<T>::iterator Deque<T>::end() {
+    unshare(mBegin, mEnd);
+    return makeEnd();
+}
+
+template<typename T>
+typename Deque<T>::iterator Deque<T>::makeBegin() noexcept {
     if (mBeginIndex == kSize - 1) {
         return iterator(&mArray[mBegin + 1], 0, mBegin + 1);
     }
@@ -531,7 +620,7 @@ typename Deque<T>::iterator Deque<T>::begin() noexcept {
 }
 
 template<typename T>
-typename Deque<T>::iterator Deque<T>::end() noexcept {
+typename Deque<T>::iterator Deque<T>::makeEnd() noexcept {
     return iterator(&mArray[mEnd], mEndIndex, mEnd);
 }
 
@@ -562,12 +651,12 @@ typename Deque<T>::const_iterator Deque<T>::cend() const noexcept {
 }
 
 template<typename T>
-typename Deque<T>::reverse_iterator Deque<T>::rbegin() noexcept {
+typename Deque<T>::reverse_iterator Deque<T>::rbegin() {
     return std::reverse_iterator(end());
 }
 
 template<typename T>
-typename Deque<T>::reverse_iterator Deque<T>::rend() noexcept {
+typename Deque<T>::reverse_iterator Deque<T>::rend() {
     return std::reverse_iterator(begin());
 }
 
@@ -593,17 +682,18 @@ typename Deque<T>::reverse_const_iterator Deque<T>::crend() const noexcept {
 
 template<typename T>
 void Deque<T>::erase(iterator it) {
-    if (it == begin()) {
+    if (it == makeBegin()) {
         pop_front();
         return;
     }
-    if (it + 1 == end()) {
+    if (it + 1 == makeEnd()) {
         pop_back();
     } else {
+        unshare(static_cast<size_t>(it.mExternalIndex), mEnd);
         int count = 0;
         T backup = *it;
         try {
-            for (; it + 1 < end(); ++it, ++count) {
+            for (; it + 1 < makeEnd(); ++it, ++count) {
                 *it = *(it + 1);
             }
             it->~T();
@@ -625,48 +715,155 @@ void Deque<T>::erase(iterator it) {
 
 template<typename T>
 void Deque<T>::insert(iterator it, const T &value) {
-    Deque<T> backup;
-    bool isExpanded = false;
-    bool isConstructedPoint = false;
+    size_t position = static_cast<size_t>(it - makeBegin());
+    reserveBack();
+    size_t origin = mBegin * kSize + mBeginIndex + 1;
+    size_t first = (origin + position) / kSize;
+    std::vector<T*> chunks(mEnd - first + 1, nullptr);
     size_t count = 0;
-    if (mEnd + 1 == mArray.size()) {
-        backup = *this;
-        isExpanded = true;
-        int lastBegin = static_cast<int>(mBegin);
-        size_t capacity = 2 * std::max(mCapacity, kSize);
-        expand(capacity);
-        it.mExternalIndex += static_cast<int>((capacity - (mEnd - mBegin)) / 2) - lastBegin;
-    }
-    iterator start(it);
-    iterator endIt(end());
-    T* point = *endIt.mPtr + endIt.mInternalIndex;
-    T backStart(*start);
-    T temp(*it);
     try {
-        new(point) T(value);
-        isConstructedPoint = true;
-        if (it != endIt) {
-            for (; it + 1 <= endIt; ++it, ++count) {
-                std::swap(temp, *(it + 1));
+        for (size_t i = first; i <= mEnd; ++i) {
+            chunks[i - first] = allocateChunk();
+            size_t last = (i == mEnd) ? mEndIndex + 1 : kSize;
+            for (size_t j = chunkBegin(i); j < last; ++j, ++count) {
+                size_t index = i * kSize + j - origin;
+                T* place = chunks[i - first] + j;
+                if (index < position) {
+                    new(place) T(mArray[i][j]);
+                } else if (index == position) {
+                    new(place) T(value);
+                } else {
+                    size_t old = origin + index - 1;
+                    new(place) T(mArray[old / kSize][old % kSize]);
+                }
             }
-            *start = value;
         }
     }
     catch (...) {
-        for (; count > 0; --it, --count) {
-            std::swap(temp, *it);
-        }
-        if (isConstructedPoint) {
-            point->~T();
+        for (size_t i = first; i <= mEnd && count > 0; ++i) {
+            size_t last = (i == mEnd) ? mEndIndex + 1 : kSize;
+            for (size_t j = chunkBegin(i); j < last && count > 0; ++j, --count) {
+                (chunks[i - first] + j)->~T();
+            }
         }
-        if (isExpanded) {
-            *this = backup;
+        for (T* chunk : chunks) {
+            delete[] reinterpret_cast<uint8_t *>(chunk);
         }
         throw;
     }
+    for (size_t i = first; i <= mEnd; ++i) {
+        disposeChunk(mArray[i], mShared[i], i);
+        if (mShared[i] != nullptr) {
+            mShared[i] = nullptr;
+            --mSharedCount;
+        }
+        mArray[i] = chunks[i - first];
+    }
     checkEndPlus();
 }
 
+template<typename T>
+typename Deque<T>::Snapshot Deque<T>::snapshot() {
+    Snapshot result(mEnd - mBegin + 1, mBeginIndex, mEnd - mBegin, mEndIndex);
+    for (size_t i = mBegin; i <= mEnd; ++i) {
+        if (chunkBegin(i) == chunkEnd(i)) {
+            continue;
+        }
+        if (mShared[i] == nullptr) {
+            mShared[i] = new SharedChunk();
+            ++mSharedCount;
+        }
+        mShared[i]->refs.fetch_add(1, std::memory_order_relaxed);
+        result.mArray[i - mBegin] = mArray[i];
+        result.mShared[i - mBegin] = mShared[i];
+    }
+    return result;
+}
+
+template<typename T>
+void Deque<T>::release(T* chunk, SharedChunk* shared) {
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        for (size_t j = shared->first; j < shared->last; ++j) {
+            (chunk + j)->~T();
+        }
+        delete[] reinterpret_cast<uint8_t *>(chunk);
+        delete shared;
+    }
+}
+
+template<typename T>
+void Deque<T>::disposeChunk(T* chunk, SharedChunk* shared, size_t index) const noexcept {
+    if (shared != nullptr) {
+        shared->first = chunkBegin(index);
+        shared->last = chunkEnd(index);
+        release(chunk, shared);
+        return;
+    }
+    for (size_t j = chunkBegin(index); j < chunkEnd(index); ++j) {
+        (chunk + j)->~T();
+    }
+    delete[] reinterpret_cast<uint8_t *>(chunk);
+}
+
+template<typename T>
+size_t Deque<T>::chunkBegin(size_t index) const noexcept {
+    return index == mBegin ? mBeginIndex + 1 : 0;
+}
+
+template<typename T>
+size_t Deque<T>::chunkEnd(size_t index) const noexcept {
+    if (index < mBegin || index > mEnd) {
+        return 0;
+    }
+    return index == mEnd ? mEndIndex : kSize;
+}
+
+template<typename T>
+void Deque<T>::unshare(size_t index) {
+    SharedChunk* shared = mShared[index];
+    if (shared == nullptr) {
+        return;
+    }
+    if (shared->refs.load(std::memory_order_acquire) == 1) {
+        delete shared;
+        mShared[index] = nullptr;
+        --mSharedCount;
+        return;
+    }
+    T* chunk = allocateChunk();
+    size_t first = chunkBegin(index);
+    size_t last = chunkEnd(index);
+    size_t j = first;
+    try {
+        for (; j < last; ++j) {
+            new(chunk + j) T(mArray[index][j]);
+        }
+    }
+    catch(...) {
+        for (; j > first; --j) {
+            (chunk + j - 1)->~T();
+        }
+        delete[] reinterpret_cast<uint8_t *>(chunk);
+        throw;
+    }
+    shared->first = first;
+    shared->last = last;
+    release(mArray[index], shared);
+    mArray[index] = chunk;
+    mShared[index] = nullptr;
+    --mSharedCount;
+}
+
+template<typename T>
+void Deque<T>::unshare(size_t first, size_t last) {
+    if (mSharedCount == 0) {
+        return;
+    }
+    for (size_t i = first; i <= last; ++i) {
+        unshare(i);
+    }
+}
+
 template<typename T>
 void Deque<T>::checkEndMinus() {
     if (mEndIndex == 0) {
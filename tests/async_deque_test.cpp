@@ -0,0 +1,197 @@
+#include <coroutine>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "async_deque.h"
+
+struct EventLoop {
+    std::deque<std::function<void()>> mTasks;
+    long mPosts = 0;
+
+    template<typename F>
+    void post(F&& task) {
+        ++mPosts;
+        mTasks.emplace_back(std::forward<F>(task));
+    }
+    void run() {
+        while (!mTasks.empty()) {
+            std::function<void()> task = std::move(mTasks.front());
+            mTasks.pop_front();
+            task();
+        }
+    }
+};
+
+struct Task {
+    struct promise_type {
+        Task get_return_object() {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+struct RethrowingTask {
+    struct promise_type {
+        RethrowingTask get_return_object() {
+            return RethrowingTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() {
+            throw;
+        }
+    };
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+using Channel = AsyncDeque<int, EventLoop>;
+
+static int gFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++gFailures; \
+            return; \
+        } \
+    } while (false)
+
+static Task produce(Channel& channel, int count, int base) {
+    for (int i = 0; i < count; ++i) {
+        co_await channel.push(base + i);
+    }
+}
+
+static Task consume(Channel& channel, int count, std::vector<int>& out) {
+    for (int i = 0; i < count; ++i) {
+        out.push_back(co_await channel.pop());
+    }
+}
+
+static void testFifoForCapacities() {
+    for (size_t capacity : {0, 1, 3, 64}) {
+        for (bool consumerFirst : {false, true}) {
+            EventLoop loop;
+            Channel channel(loop, capacity);
+            std::vector<int> out;
+            if (consumerFirst) {
+                consume(channel, 1000, out);
+                produce(channel, 1000, 0);
+            } else {
+                produce(channel, 1000, 0);
+                consume(channel, 1000, out);
+            }
+            loop.run();
+            CHECK(out.size() == 1000);
+            for (int i = 0; i < 1000; ++i) {
+                CHECK(out[static_cast<size_t>(i)] == i);
+            }
+            CHECK(channel.empty());
+        }
+    }
+}
+
+static void testBackpressure() {
+    EventLoop loop;
+    Channel channel(loop, 4);
+    produce(channel, 10, 0);
+    CHECK(channel.size() == 4);
+    std::vector<int> out;
+    consume(channel, 10, out);
+    loop.run();
+    CHECK(out.size() == 10);
+    CHECK(channel.empty());
+    CHECK(loop.mPosts < 10);
+}
+
+static void testDestroyWithPendingFlush() {
+    EventLoop loop;
+    std::vector<int> out;
+    {
+        Channel channel(loop, 4);
+        consume(channel, 1, out);
+        produce(channel, 1, 7);
+        CHECK(loop.mTasks.size() == 1);
+        CHECK(out.empty());
+    }
+    loop.run();
+    CHECK(out.size() == 1 && out[0] == 7);
+}
+
+static Task consumeThenDestroy(std::unique_ptr<Channel>& channel, std::vector<int>& out) {
+    out.push_back(co_await channel->pop());
+    channel.reset();
+}
+
+static void testDestroyInsideFlush() {
+    EventLoop loop;
+    std::vector<int> out;
+    auto channel = std::make_unique<Channel>(loop, 4);
+    consumeThenDestroy(channel, out);
+    consume(*channel, 1, out);
+    produce(*channel, 2, 1);
+    loop.run();
+    CHECK(channel == nullptr);
+    CHECK(out.size() == 2 && out[0] == 1 && out[1] == 2);
+}
+
+static RethrowingTask consumeThenThrow(Channel& channel, std::vector<int>& out) {
+    out.push_back(co_await channel.pop());
+    throw 1;
+}
+
+static void testThrowingResumeIsNotRepeated() {
+    EventLoop loop;
+    Channel channel(loop, 4);
+    std::vector<int> out;
+    RethrowingTask thrower = consumeThenThrow(channel, out);
+    consume(channel, 1, out);
+    consume(channel, 1, out);
+    produce(channel, 3, 1);
+    bool threw = false;
+    try {
+        loop.run();
+    }
+    catch (int) {
+        threw = true;
+    }
+    CHECK(threw);
+    loop.run();
+    thrower.mHandle.destroy();
+    CHECK(out.size() == 3 && out[0] == 1 && out[1] == 2 && out[2] == 3);
+    produce(channel, 1, 4);
+    loop.run();
+    CHECK(channel.size() == 1);
+}
+
+int main() {
+    testFifoForCapacities();
+    testBackpressure();
+    testDestroyWithPendingFlush();
+    testDestroyInsideFlush();
+    testThrowingResumeIsNotRepeated();
+    std::printf("failures: %d\n", gFailures);
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <deque>
+#include "deque.h"
+#include "fault_injection.h"
+
+static bool sameContents(const Deque<Value>& deque, const std::deque<int>& reference) {
+    if (deque.size() != reference.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (auto it = deque.cbegin(); it != deque.cend(); ++it, ++i) {
+        if (it->mValue != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Budgets reach well past the first allocation or copy, so faults also land mid-operation.
+static void armFault(unsigned& seed) {
+    seed = seed * 1103515245u + 12345u;
+    unsigned roll = (seed >> 16) % 16;
+    if (roll == 0) {
+        gAllocationBudget = static_cast<long>((seed >> 8) % 40);
+    } else if (roll == 1) {
+        gCopyBudget = static_cast<long>((seed >> 8) % 40);
+    }
+}
+
+static void testStrongGuaranteeUnderFaults() {
+    long allocationsBefore = gLiveAllocations;
+    unsigned seed = 1;
+    for (int round = 0; round < 300; ++round) {
+        Deque<Value> deque;
+        std::deque<int> reference;
+        for (int step = 0; step < 400; ++step) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned operation = (seed >> 16) % 6;
+            int value = static_cast<int>(seed >> 4);
+            Value element(value);
+            size_t position = (seed >> 8) % (reference.size() + 1);
+            armFault(seed);
+            try {
+                if (operation <= 1) {
+                    deque.push_back(element);
+                    disarmFaults();
+                    reference.push_back(value);
+                } else if (operation <= 3) {
+                    deque.push_front(element);
+                    disarmFaults();
+                    reference.push_front(value);
+                } else if (operation == 4) {
+                    deque.insert(deque.begin() + static_cast<int>(position), element);
+                    disarmFaults();
+                    reference.insert(reference.begin() + static_cast<long>(position), value);
+                } else if (!reference.empty()) {
+                    deque.pop_back();
+                    disarmFaults();
+                    reference.pop_back();
+                }
+            }
+            catch (...) {
+            }
+            disarmFaults();
+            CHECK(sameContents(deque, reference));
+            CHECK(gLiveValues == static_cast<long>(reference.size()) + 1);
+        }
+    }
+    CHECK(gLiveValues == 0);
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+static void testGrowthKeepsOrder() {
+    long allocationsBefore = gLiveAllocations;
+    {
+        Deque<int> deque;
+        for (int i = 0; i < 100000; ++i) {
+            deque.push_back(i);
+            deque.push_front(-i);
+        }
+        CHECK(deque.size() == 200000);
+        for (int i = 0; i < 100000; ++i) {
+            CHECK(deque[static_cast<size_t>(99999 - i)] == -i);
+            CHECK(deque[static_cast<size_t>(100000 + i)] == i);
+        }
+        Deque<int> sized(1000, 7);
+        for (int i = 0; i < 5000; ++i) {
+            sized.push_back(i);
+        }
+        CHECK(sized[999] == 7);
+        CHECK(sized[5999] == 4999);
+    }
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+int main() {
+    testStrongGuaranteeUnderFaults();
+    testGrowthKeepsOrder();
+    std::printf("injected throws: %ld, failures: %d\n", gInjectedThrows, gFailures);
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+#include <chrono>
+#include <deque>
+#include "deque.h"
+#include "fault_injection.h"
+
+static bool sameContents(const Deque<Value>::Snapshot& snapshot, const std::deque<int>& reference) {
+    if (snapshot.size() != reference.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it, ++i) {
+        if (it->mValue != reference[i] || snapshot[i].mValue != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameContents(const Deque<Value>& deque, const std::deque<int>& reference) {
+    if (deque.size() != reference.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (auto it = deque.cbegin(); it != deque.cend(); ++it, ++i) {
+        if (it->mValue != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void fill(Deque<Value>& deque, std::deque<int>& reference, int count) {
+    for (int i = 0; i < count; ++i) {
+        deque.push_back(Value(i));
+        reference.push_back(i);
+    }
+}
+
+static void testSnapshotSurvivesMutations() {
+    long allocationsBefore = gLiveAllocations;
+    {
+        Deque<Value> deque;
+        std::deque<int> reference;
+        fill(deque, reference, 100);
+        const std::deque<int> expected = reference;
+        Deque<Value>::Snapshot snapshot = deque.snapshot();
+
+        deque[5] = Value(-1);
+        reference[5] = -1;
+        CHECK(sameContents(deque, reference));
+        CHECK(sameContents(snapshot, expected));
+
+        deque.insert(deque.begin() + 10, Value(-2));
+        reference.insert(reference.begin() + 10, -2);
+        CHECK(sameContents(deque, reference));
+        CHECK(sameContents(snapshot, expected));
+
+        deque.erase(deque.begin() + 20);
+        reference.erase(reference.begin() + 20);
+        CHECK(sameContents(deque, reference));
+        CHECK(sameContents(snapshot, expected));
+
+        deque.pop_back();
+        reference.pop_back();
+        deque.pop_front();
+        reference.pop_front();
+        CHECK(sameContents(deque, reference));
+        CHECK(sameContents(snapshot, expected));
+
+        Deque<Value> other;
+        other.push_back(Value(-3));
+        deque = other;
+        CHECK(sameContents(deque, std::deque<int>{-3}));
+        CHECK(sameContents(snapshot, expected));
+    }
+    CHECK(gLiveValues == 0);
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+static void testAppendsDoNotCopyChunks() {
+    Deque<Value> deque;
+    std::deque<int> reference;
+    fill(deque, reference, 100);
+    Deque<Value>::Snapshot snapshot = deque.snapshot();
+    Value element(7);
+    long copiesBefore = gCopies;
+    for (int i = 0; i < 1000; ++i) {
+        deque.push_back(element);
+    }
+    for (int i = 0; i < 100; ++i) {
+        deque.push_front(element);
+    }
+    CHECK(gCopies - copiesBefore == 1100);
+    CHECK(deque.size() == 1200);
+    CHECK(sameContents(snapshot, std::deque<int>(reference)));
+}
+
+static void testSnapshotOutlivesDeque() {
+    long allocationsBefore = gLiveAllocations;
+    {
+        std::deque<int> reference;
+        Deque<Value>* deque = new Deque<Value>();
+        fill(*deque, reference, 37);
+        Deque<Value>::Snapshot snapshot = deque->snapshot();
+        Deque<Value>::Snapshot copy = snapshot;
+        deque->push_back(Value(100));
+        deque->push_front(Value(-100));
+        delete deque;
+        CHECK(sameContents(snapshot, reference));
+        CHECK(sameContents(copy, reference));
+        copy = snapshot;
+        CHECK(sameContents(copy, reference));
+    }
+    CHECK(gLiveValues == 0);
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+static void testDequeOutlivesSnapshot() {
+    long allocationsBefore = gLiveAllocations;
+    {
+        Deque<Value> deque;
+        std::deque<int> reference;
+        fill(deque, reference, 37);
+        {
+            Deque<Value>::Snapshot snapshot = deque.snapshot();
+            deque.push_back(Value(37));
+            reference.push_back(37);
+        }
+        deque.pop_back();
+        reference.pop_back();
+        deque[0] = Value(-1);
+        reference[0] = -1;
+        CHECK(sameContents(deque, reference));
+        Deque<Value>::Snapshot dropped = deque.snapshot();
+        dropped = Deque<Value>().snapshot();
+    }
+    CHECK(gLiveValues == 0);
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+static void testUnshareFailures() {
+    long allocationsBefore = gLiveAllocations;
+    for (int mode = 0; mode < 2; ++mode) {
+        for (long budget = 0; budget <= static_cast<long>(kSize) + 2; ++budget) {
+            Deque<Value> deque;
+            std::deque<int> reference;
+            fill(deque, reference, 40);
+            const std::deque<int> expected = reference;
+            Deque<Value>::Snapshot snapshot = deque.snapshot();
+            Value replacement(-1);
+            if (mode == 0) {
+                gAllocationBudget = budget;
+            } else {
+                gCopyBudget = budget;
+            }
+            bool threw = false;
+            try {
+                deque[20] = replacement;
+            }
+            catch (...) {
+                threw = true;
+            }
+            disarmFaults();
+            if (!threw) {
+                reference[20] = -1;
+            }
+            long failingBudgets = static_cast<long>(kSize) + (mode == 0 ? 1 : 0);
+            CHECK(threw == (budget < failingBudgets));
+            CHECK(sameContents(deque, reference));
+            CHECK(sameContents(snapshot, expected));
+        }
+    }
+    CHECK(gLiveValues == 0);
+    CHECK(gLiveAllocations == allocationsBefore);
+}
+
+static double iterateMutably(Deque<int>& deque, long& sum) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto it = deque.begin(); it != deque.end(); ++it) {
+        sum += *it;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A loop calling end() every step must stay linear; rescanning the map per call takes minutes here.
+static void testMutableIterationIsLinear() {
+    const int count = 1000000;
+    Deque<int> deque;
+    for (int i = 0; i < count; ++i) {
+        deque.push_back(1);
+    }
+    long sum = 0;
+    CHECK(iterateMutably(deque, sum) < 2.0);
+    {
+        Deque<int>::Snapshot snapshot = deque.snapshot();
+        CHECK(iterateMutably(deque, sum) < 2.0);
+        CHECK(snapshot.size() == static_cast<size_t>(count));
+    }
+    Deque<int>::Snapshot released = deque.snapshot();
+    released = Deque<int>(0).snapshot();
+    CHECK(iterateMutably(deque, sum) < 2.0);
+    CHECK(sum == 3L * count);
+}
+
+int main() {
+    testSnapshotSurvivesMutations();
+    testAppendsDoNotCopyChunks();
+    testSnapshotOutlivesDeque();
+    testDequeOutlivesSnapshot();
+    testUnshareFailures();
+    testMutableIterationIsLinear();
+    std::printf("injected throws: %ld, failures: %d\n", gInjectedThrows, gFailures);
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+// Global allocation hooks for fault-injection tests; include from exactly one source per test binary.
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// Every allocation goes through a budget: once it reaches zero the next allocation throws.
+static long gAllocationBudget = -1;
+static long gLiveAllocations = 0;
+static long gInjectedThrows = 0;
+
+static void* allocate(size_t size) {
+    if (gAllocationBudget == 0) {
+        ++gInjectedThrows;
+        throw std::bad_alloc();
+    }
+    if (gAllocationBudget > 0) {
+        --gAllocationBudget;
+    }
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    ++gLiveAllocations;
+    return memory;
+}
+
+static void deallocate(void* memory) noexcept {
+    if (memory != nullptr) {
+        --gLiveAllocations;
+        std::free(memory);
+    }
+}
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    deallocate(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    deallocate(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    deallocate(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    deallocate(memory);
+}
+
+static long gCopyBudget = -1;
+static long gLiveValues = 0;
+static long gCopies = 0;
+
+struct Value {
+    int mValue;
+    std::string mPayload;
+
+    explicit Value(int value) : mValue(value), mPayload(32, 'x') {
+        ++gLiveValues;
+    }
+    Value(const Value& other) : mValue(other.mValue), mPayload(other.mPayload) {
+        if (gCopyBudget == 0) {
+            ++gInjectedThrows;
+            throw std::runtime_error("injected copy failure");
+        }
+        if (gCopyBudget > 0) {
+            --gCopyBudget;
+        }
+        ++gCopies;
+        ++gLiveValues;
+    }
+    Value& operator=(const Value& other) {
+        mValue = other.mValue;
+        return *this;
+    }
+    ~Value() {
+        --gLiveValues;
+    }
+};
+
+static int gFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++gFailures; \
+            return; \
+        } \
+    } while (false)
+
+static void disarmFaults() {
+    gAllocationBudget = -1;
+    gCopyBudget = -1;
+}